@@ -2,3 +2,7 @@
 #define PLATFORM_IMX6	6
 
 #define CFG_PLATFORM		PLATFORM_IMX6
+
+/* Run the DDR read/write delay and DQS gating margin scan after SDRAM init
+ * and stream the result over the debug UART (iMX6 only, see ddr_scan.h). */
+#define CFG_DDR_MARGIN_SCAN	0
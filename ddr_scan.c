@@ -0,0 +1,334 @@
+/*
+ * iMX boot ROM plugin: DDR margin scanner.
+ *
+ * Sweeps the MMDC read/write delay lines and DQS gating delay of all byte
+ * lanes around the calibrated values, runs a short pattern test at every
+ * point and streams the per-lane pass/fail map over the debug UART.
+ * The frame format is described in ddr_scan.h, tools/ddr_eye.py decodes it.
+ *
+ * Copyright (C) 2016 Artec Design LLC
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license.  See the LICENSE file for details.
+ *
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "serial.h"
+#include "config.h"
+#include "ddr_scan.h"
+
+#if CFG_DDR_MARGIN_SCAN
+
+/* iMX6D/Q/DL/S with DDR3 only, the SoC and memory type are checked at run time.
+ * iMX6SL/SX have DRAM at 0x80000000 and iMX6SL uses LPDDR2. */
+#if CFG_PLATFORM != PLATFORM_IMX6
+#error "DDR margin scan is implemented for iMX6D/Q/DL/S MMDC only"
+#endif
+
+#define __REG(x)     	(*((volatile uint32_t *)(x)))
+
+/* MMDC1 serves byte lanes 0..3, MMDC2 lanes 4..7 (64-bit bus only) */
+#define MMDC1_BASE				0x021b0000
+#define MMDC2_BASE				0x021b4000
+
+#define MMDC_MDCTL				0x000
+#define MMDC_MDMISC				0x018
+#define MMDC_MPDGCTRL0			0x83c
+#define MMDC_MPDGCTRL1			0x840
+#define MMDC_MPRDDLCTL			0x848
+#define MMDC_MPWRDLCTL			0x850
+#define MMDC_MPMUR0				0x8b8
+
+#define MDCTL_DSIZ(x)			(((x) >> 16) & 0x3)
+#define MDMISC_DDR_TYPE(x)		(((x) >> 3) & 0x3)
+#define MPDGCTRL0_RST_RD_FIFO	(1 << 31)
+#define MPMUR0_FRC_MSR			(1 << 11)
+
+#define DL_MAX					0x7f
+/* DG_HC_DEL (4 bits, half cycles) : DG_DL_ABS_OFFSET (7 bits) */
+#define DG_MAX					0x7ff
+
+#define REG_ANATOP_DIGPROG		0x020C8260
+#define REG_ANATOP_DIGPROG_SL	0x020C8280
+
+/* PL310 L2 cache controller */
+#define L2_CTRL					__REG(0x00A02100)
+#define L2_CACHE_SYNC			__REG(0x00A02730)
+#define L2_CLEAN_INV_LINE_PA	__REG(0x00A027F0)
+
+#define CACHE_LINE				32
+
+/* Test area at the start of SDRAM. The caches are cleaned and invalidated
+ * over it after every fill and before every check, so that the data always
+ * goes through the DRAM interface under test. */
+#define SCAN_ADDR				0x10000000
+#define SCAN_SIZE				(64 * 1024)
+
+/* Sweep ranges, relative to the calibrated value of each lane */
+#define SCAN_POINTS_MAX			128
+#define SCAN_DL_START			(-128)
+#define SCAN_DL_STEP			2
+#define SCAN_DG_START			(-256)
+#define SCAN_DG_STEP			4
+
+#define MAX_LANES				8
+
+///////////////////////////////////////////////////////////////////////////////
+static uint32_t mmdc_base(int lane) {
+	return lane < 4 ? MMDC1_BASE : MMDC2_BASE;
+}
+
+static int mmdc_lanes() {
+	switch (MDCTL_DSIZ(__REG(MMDC1_BASE + MMDC_MDCTL))) {
+	case 0: return 2;
+	case 1: return 4;
+	default: return 8;
+	}
+}
+
+static uint32_t dl_reg(enum ddr_scan_type type) {
+	return type == DDR_SCAN_READ_DELAY ? MMDC_MPRDDLCTL : MMDC_MPWRDLCTL;
+}
+
+static uint32_t dg_reg(int lane) {
+	return (lane & 3) < 2 ? MMDC_MPDGCTRL0 : MMDC_MPDGCTRL1;
+}
+
+static uint16_t get_delay(enum ddr_scan_type type, int lane) {
+	uint32_t base = mmdc_base(lane);
+
+	if (type == DDR_SCAN_DQS_GATING) {
+		uint32_t v = __REG(base + dg_reg(lane)) >> ((lane & 1) * 16);
+		return ((v >> 8) & 0xf) << 7 | (v & 0x7f);
+	}
+
+	return (__REG(base + dl_reg(type)) >> ((lane & 3) * 8)) & DL_MAX;
+}
+
+static void set_delay(enum ddr_scan_type type, int lane, uint16_t val) {
+	uint32_t base = mmdc_base(lane);
+
+	if (type == DDR_SCAN_DQS_GATING) {
+		volatile uint32_t *reg = &__REG(base + dg_reg(lane));
+		int shift = (lane & 1) * 16;
+		uint32_t v = *reg & ~MPDGCTRL0_RST_RD_FIFO;
+		v &= ~((0xf << 8 | 0x7f) << shift);
+		v |= ((val >> 7) << 8 | (val & 0x7f)) << shift;
+		*reg = v;
+		return;
+	}
+
+	volatile uint32_t *reg = &__REG(base + dl_reg(type));
+	int shift = (lane & 3) * 8;
+	*reg = (*reg & ~(DL_MAX << shift)) | (uint32_t)val << shift;
+}
+
+/* Latch the new delay values and flush whatever the read FIFOs got while
+ * the delays were being changed. */
+static void mmdc_update(int lanes) {
+	int i;
+	for (i = 0; i < (lanes > 4 ? 2 : 1); i++) {
+		uint32_t base = i ? MMDC2_BASE : MMDC1_BASE;
+		__REG(base + MMDC_MPMUR0) = MPMUR0_FRC_MSR;
+		while (__REG(base + MMDC_MPMUR0) & MPMUR0_FRC_MSR);
+		__REG(base + MMDC_MPDGCTRL0) |= MPDGCTRL0_RST_RD_FIFO;
+		while (__REG(base + MMDC_MPDGCTRL0) & MPDGCTRL0_RST_RD_FIFO);
+	}
+}
+
+/* Write back and drop the test area from L1 (if enabled by ROM) and L2 */
+static void cache_flush() {
+	uint32_t sctlr, addr;
+
+	asm volatile ("mrc p15, 0, %0, c1, c0, 0" : "=r" (sctlr));
+	if (sctlr & (1 << 2)) {
+		for (addr = SCAN_ADDR; addr < SCAN_ADDR + SCAN_SIZE; addr += CACHE_LINE) {
+			/* DCCIMVAC */
+			asm volatile ("mcr p15, 0, %0, c7, c14, 1" : : "r" (addr) : "memory");
+		}
+		asm volatile ("dsb" : : : "memory");
+	}
+
+	if (L2_CTRL & 1) {
+		for (addr = SCAN_ADDR; addr < SCAN_ADDR + SCAN_SIZE; addr += CACHE_LINE) {
+			L2_CLEAN_INV_LINE_PA = addr;
+		}
+		L2_CACHE_SYNC = 0;
+		while (L2_CACHE_SYNC & 1);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/* Pseudo-random data, inverted on every other 64-bit beat to toggle all the
+ * DQ lines. The seed changes per point, so that data left in SDRAM by the
+ * previous point can't pass the write delay test. */
+static uint32_t pattern(uint32_t i, uint32_t seed) {
+	uint32_t x = (i + seed * 0x10001) * 0x9E3779B9;
+	x ^= x >> 15;
+	return (i & 2) ? ~x : x;
+}
+
+static void pattern_fill(uint32_t seed) {
+	volatile uint32_t *mem = (volatile uint32_t *)SCAN_ADDR;
+	uint32_t i;
+	for (i = 0; i < SCAN_SIZE / 4; i++) {
+		mem[i] = pattern(i, seed);
+	}
+	cache_flush();
+}
+
+/* Mask of bytes in word that have any bits set */
+static uint8_t byte_mask(uint32_t v) {
+	return (v & 0x000000ff ? 0x1 : 0) | (v & 0x0000ff00 ? 0x2 : 0) |
+		(v & 0x00ff0000 ? 0x4 : 0) | (v & 0xff000000 ? 0x8 : 0);
+}
+
+/* Returns mask of failed byte lanes */
+static uint8_t pattern_check(uint32_t seed, int lanes) {
+	volatile uint32_t *mem = (volatile uint32_t *)SCAN_ADDR;
+	/* On 64-bit bus, even words are on lanes 0..3, odd ones on 4..7 */
+	uint32_t err[2] = { 0, 0 };
+	uint32_t i;
+
+	cache_flush();
+	for (i = 0; i < SCAN_SIZE / 4; i++) {
+		err[i & 1] |= mem[i] ^ pattern(i, seed);
+	}
+
+	if (lanes == 8) {
+		return byte_mask(err[0]) | byte_mask(err[1]) << 4;
+	}
+	err[0] |= err[1];
+	if (lanes == 2) {
+		err[0] |= err[0] >> 16;
+	}
+	return byte_mask(err[0]) & ((1 << lanes) - 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+static uint16_t scan_crc;
+
+static void scan_out(const void *data, size_t len) {
+	const uint8_t *p = data;
+	size_t n;
+	int i;
+
+	/* CRC-16/CCITT-FALSE */
+	for (n = 0; n < len; n++) {
+		scan_crc ^= (uint16_t)p[n] << 8;
+		for (i = 0; i < 8; i++) {
+			scan_crc = scan_crc & 0x8000 ? (scan_crc << 1) ^ 0x1021 : scan_crc << 1;
+		}
+	}
+	dbg_bin(data, len);
+}
+
+static void scan_out_u16(uint16_t v) {
+	uint8_t b[2] = { v & 0xff, v >> 8 };
+	scan_out(b, sizeof(b));
+}
+
+static void scan_sweep(enum ddr_scan_type type, int lanes,
+		int start, int step, int points, int max) {
+	static uint8_t map[MAX_LANES][SCAN_POINTS_MAX / 8];
+	uint16_t nominal[MAX_LANES];
+	int lane, n;
+
+	for (lane = 0; lane < lanes; lane++) {
+		nominal[lane] = get_delay(type, lane);
+		for (n = 0; n < SCAN_POINTS_MAX / 8; n++) {
+			map[lane][n] = 0;
+		}
+	}
+
+	/* Read side delays don't affect the stored data, write it only once */
+	if (type != DDR_SCAN_WRITE_DELAY) {
+		pattern_fill(type);
+	}
+
+	for (n = 0; n < points; n++) {
+		uint32_t seed = type;
+		uint8_t fail = 0;
+
+		for (lane = 0; lane < lanes; lane++) {
+			int v = nominal[lane] + start + n * step;
+			if (v < 0 || v > max) {
+				fail |= 1 << lane;
+				v = nominal[lane];
+			}
+			set_delay(type, lane, v);
+		}
+		mmdc_update(lanes);
+
+		if (type == DDR_SCAN_WRITE_DELAY) {
+			seed = (n + 1) << 2 | type;
+			pattern_fill(seed);
+		}
+		fail |= pattern_check(seed, lanes);
+
+		for (lane = 0; lane < lanes; lane++) {
+			if (!(fail & (1 << lane))) {
+				map[lane][n / 8] |= 1 << (n % 8);
+			}
+		}
+	}
+
+	for (lane = 0; lane < lanes; lane++) {
+		set_delay(type, lane, nominal[lane]);
+	}
+	mmdc_update(lanes);
+
+	uint8_t hdr[2] = { type, 0 };
+	scan_out(hdr, sizeof(hdr));
+	scan_out_u16(start);
+	scan_out_u16(step);
+	scan_out_u16(points);
+	for (lane = 0; lane < lanes; lane++) {
+		scan_out_u16(nominal[lane]);
+	}
+	for (lane = 0; lane < lanes; lane++) {
+		scan_out(map[lane], (points + 7) / 8);
+	}
+}
+
+static int scan_supported() {
+	/* iMX6SL */
+	if (((__REG(REG_ANATOP_DIGPROG_SL) >> 16) & 0xFF) == 0x60) return 0;
+
+	/* iMX6DQ / iMX6DQP / iMX6DL / iMX6S */
+	uint32_t type = (__REG(REG_ANATOP_DIGPROG) >> 16) & 0xFF;
+	if (type != 0x63 && type != 0x61) return 0;
+
+	/* DDR3 */
+	return MDMISC_DDR_TYPE(__REG(MMDC1_BASE + MMDC_MDMISC)) == 0;
+}
+
+void ddr_margin_scan(void) {
+	if (!scan_supported()) {
+		dbg_str("DDR margin scan: unsupported SoC or memory type\n");
+		return;
+	}
+
+	int lanes = mmdc_lanes();
+
+	dbg_str("DDR margin scan\n");
+
+	uint8_t hdr[8] = { 'D', 'D', 'R', 'M', DDR_SCAN_VERSION, lanes, 3, 0 };
+	scan_crc = 0xffff;
+	scan_out(hdr, sizeof(hdr));
+
+	scan_sweep(DDR_SCAN_READ_DELAY, lanes,
+			SCAN_DL_START, SCAN_DL_STEP, SCAN_POINTS_MAX, DL_MAX);
+	scan_sweep(DDR_SCAN_WRITE_DELAY, lanes,
+			SCAN_DL_START, SCAN_DL_STEP, SCAN_POINTS_MAX, DL_MAX);
+	scan_sweep(DDR_SCAN_DQS_GATING, lanes,
+			SCAN_DG_START, SCAN_DG_STEP, SCAN_POINTS_MAX, DG_MAX);
+
+	scan_out_u16(scan_crc);
+
+	dbg_str("\nDDR margin scan done\n");
+}
+
+#endif /* CFG_DDR_MARGIN_SCAN */
@@ -0,0 +1,39 @@
+/*
+ * iMX boot ROM plugin: DDR margin scanner.
+ *
+ * The scan result is sent over the debug UART as a single binary frame.
+ * All multi-byte fields are little endian.
+ *
+ * header:
+ *   u8  magic[4]		"DDRM"
+ *   u8  version		DDR_SCAN_VERSION
+ *   u8  lanes			number of byte lanes
+ *   u8  sweeps			number of sweep records that follow
+ *   u8  reserved
+ * sweep record (repeated):
+ *   u8  type			enum ddr_scan_type
+ *   u8  reserved
+ *   s16 start			delay offset of the first point, relative to nominal
+ *   u16 step			delay offset increment between points
+ *   u16 points			number of points
+ *   u16 nominal[lanes]	calibrated delay value per lane
+ *   u8  map[lanes][(points + 7) / 8]
+ *						pass bitmap per lane, point n is bit (n % 8) of
+ *						byte (n / 8); set = pattern test passed
+ * trailer:
+ *   u16 crc			CRC-16/CCITT-FALSE of everything above
+ *
+ * Read and write delays are in MMDC delay line units (1/256 cycle), DQS
+ * gating delay is HC_DEL * 128 + ABS_OFFSET in the same units.
+ * Points that fall outside of the register range are reported as failed.
+ */
+
+#define DDR_SCAN_VERSION	1
+
+enum ddr_scan_type {
+	DDR_SCAN_READ_DELAY = 0,	/* MPRDDLCTL */
+	DDR_SCAN_WRITE_DELAY = 1,	/* MPWRDLCTL */
+	DDR_SCAN_DQS_GATING = 2,	/* MPDGCTRL0/1 */
+};
+
+void ddr_margin_scan(void);
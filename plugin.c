@@ -14,6 +14,7 @@
 #include "serial.h"
 #include "board.h"
 #include "config.h"
+#include "ddr_scan.h"
 
 /* iMX boot ROM looks for iMX header at this offset */
 #define FLASH_OFFSET				0x400
@@ -250,6 +251,10 @@ int plugin_download(void **start, uint32_t *bytes, uint32_t *ivt_offset) {
 		return 0;
 	}
 
+#if CFG_DDR_MARGIN_SCAN
+	ddr_margin_scan();
+#endif
+
 	/* If start pointer is not in SRAM, we're serial downloading. */
 	if (start < (void**)0x00900000) {
 		/* Go back to failsafe (serial loader) to continue loading. */
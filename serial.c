@@ -104,13 +104,18 @@ void dbg_init(void)
 	UART_UCR1 = UCR1_UARTEN;
 }
 
+static void dbg_raw(const uint8_t c)
+{
+	UART_UTXD = c;
+	while (!(UART_UTS & UTS_TXEMPTY));
+}
+
 void dbg_chr(const char c)
 {
 	if (c == '\n')
-		dbg_chr ('\r');
+		dbg_raw('\r');
 
-	UART_UTXD = c;
-	while (!(UART_UTS & UTS_TXEMPTY));
+	dbg_raw(c);
 }
 
 void dbg_str(const char *str)
@@ -119,3 +124,12 @@ void dbg_str(const char *str)
 		dbg_chr(*str++);
 	}
 }
+
+/* Send binary data as-is, without newline translation. */
+void dbg_bin(const void *data, size_t len)
+{
+	const uint8_t *p = data;
+	while (len--) {
+		dbg_raw(*p++);
+	}
+}
@@ -1,4 +1,6 @@
+#include <stddef.h>
 
 void dbg_init(void);
 void dbg_chr(const char c);
 void dbg_str(const char *str);
+void dbg_bin(const void *data, size_t len);
@@ -0,0 +1,217 @@
+#!/usr/bin/env python3
+#
+# iMX boot ROM plugin: DDR margin scan decoder.
+#
+# Reads the debug UART capture of a plugin built with CFG_DDR_MARGIN_SCAN,
+# renders the per-lane eye maps and flags lanes with too little margin.
+# The frame format is described in ddr_scan.h.
+#
+# Copyright (C) 2016 Artec Design LLC
+#
+# This software may be modified and distributed under the terms
+# of the BSD license.  See the LICENSE file for details.
+#
+# Usage:
+#   stty -F /dev/ttyUSB0 115200 raw
+#   ddr_eye.py /dev/ttyUSB0
+#   ddr_eye.py capture.bin --min-margin 24 --min-gating-margin 96
+#
+# The read/write delay and DQS gating sweeps have separate margin thresholds,
+# as the gating window spans a much wider delay range.
+#
+# Exit code: 0 = all lanes pass, 1 = marginal unit, 2 = usage error,
+# 3 = no valid scan found.
+
+import argparse
+import struct
+import sys
+
+MAGIC = b'DDRM'
+VERSION = 1
+
+SWEEP_DQS_GATING = 2
+
+EXIT_PASS = 0
+EXIT_MARGINAL = 1
+EXIT_NO_FRAME = 3
+
+SWEEP_NAMES = {
+    0: 'read delay',
+    1: 'write delay',
+    SWEEP_DQS_GATING: 'DQS gating',
+}
+
+
+def crc16_ccitt(data, crc=0xffff):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xffff
+    return crc
+
+
+class Sweep:
+    def __init__(self, kind, start, step, nominal, passed):
+        self.kind = kind
+        self.start = start
+        self.step = step
+        self.nominal = nominal  # per lane
+        self.passed = passed    # per lane list of bools
+
+    def offset(self, n):
+        return self.start + n * self.step
+
+    def eye(self, lane):
+        """Returns (left, right) delay offsets of the passing window that
+        contains the calibrated value, or None if the calibrated value fails.
+        """
+        p = self.passed[lane]
+        points = len(p)
+        # the point closest to offset 0
+        n0 = min(range(points), key=lambda n: abs(self.offset(n)))
+        if not p[n0]:
+            return None
+        lo = hi = n0
+        while lo > 0 and p[lo - 1]:
+            lo -= 1
+        while hi < points - 1 and p[hi + 1]:
+            hi += 1
+        return self.offset(lo), self.offset(hi)
+
+
+def parse_frame(data, pos):
+    """Parses a frame at pos. Returns (lanes, sweeps, end) or raises ValueError."""
+    hdr = data[pos:pos + 8]
+    if len(hdr) < 8:
+        raise ValueError('truncated header')
+    _, version, lanes, nsweeps, _ = struct.unpack('<4sBBBB', hdr)
+    if version != VERSION:
+        raise ValueError('unsupported version %d' % version)
+    if lanes == 0 or nsweeps == 0:
+        raise ValueError('empty scan')
+    p = pos + 8
+    sweeps = []
+    for _ in range(nsweeps):
+        fixed = data[p:p + 8]
+        if len(fixed) < 8:
+            raise ValueError('truncated sweep')
+        kind, _, start, step, points = struct.unpack('<BBhHH', fixed)
+        if points == 0:
+            raise ValueError('empty sweep')
+        p += 8
+        nominal = struct.unpack('<%dH' % lanes, data[p:p + 2 * lanes])
+        p += 2 * lanes
+        mapsize = (points + 7) // 8
+        passed = []
+        for _ in range(lanes):
+            m = data[p:p + mapsize]
+            if len(m) < mapsize:
+                raise ValueError('truncated map')
+            passed.append([bool(m[n // 8] & (1 << (n % 8))) for n in range(points)])
+            p += mapsize
+        sweeps.append(Sweep(kind, start, step, nominal, passed))
+    if len(data) < p + 2:
+        raise ValueError('truncated trailer')
+    crc, = struct.unpack('<H', data[p:p + 2])
+    if crc16_ccitt(data[pos:p]) != crc:
+        raise ValueError('CRC mismatch')
+    return lanes, sweeps, p + 2
+
+
+def find_frame(data):
+    """Returns the last valid frame in the capture."""
+    found = None
+    pos = data.find(MAGIC)
+    while pos >= 0:
+        try:
+            lanes, sweeps, end = parse_frame(data, pos)
+            found = (lanes, sweeps)
+            pos = data.find(MAGIC, end)
+        except (ValueError, struct.error):
+            pos = data.find(MAGIC, pos + 1)
+    return found
+
+
+def read_capture(path, timeout):
+    if path == '-':
+        return sys.stdin.buffer.read()
+    if not path.startswith('/dev/'):
+        with open(path, 'rb') as f:
+            return f.read()
+    # Serial port: read until a complete frame has been received
+    import os
+    import select
+    fd = os.open(path, os.O_RDONLY | os.O_NOCTTY)
+    data = b''
+    try:
+        while True:
+            r, _, _ = select.select([fd], [], [], timeout)
+            if not r:
+                break
+            chunk = os.read(fd, 4096)
+            if not chunk:
+                break
+            data += chunk
+            if find_frame(data):
+                break
+    finally:
+        os.close(fd)
+    return data
+
+
+def render(sweep, lane):
+    return ''.join('|' if sweep.offset(n) == 0 else ('#' if ok else '.')
+                   for n, ok in enumerate(sweep.passed[lane]))
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Decode iMX plugin DDR margin scan')
+    ap.add_argument('capture', help='capture file, serial device or - for stdin')
+    ap.add_argument('--min-margin', type=int, default=16,
+                    help='minimum distance from calibrated value to eye edge '
+                         'for read/write delay (delay units, default %(default)s)')
+    ap.add_argument('--min-gating-margin', type=int, default=64,
+                    help='minimum distance from calibrated value to eye edge '
+                         'for DQS gating (delay units, default %(default)s)')
+    ap.add_argument('--timeout', type=float, default=30,
+                    help='serial port inactivity timeout in seconds')
+    ap.add_argument('-q', '--quiet', action='store_true',
+                    help='do not render the eye maps')
+    args = ap.parse_args()
+
+    frame = find_frame(read_capture(args.capture, args.timeout))
+    if frame is None:
+        print('no valid DDR margin scan found', file=sys.stderr)
+        return EXIT_NO_FRAME
+    lanes, sweeps = frame
+
+    marginal = False
+    for s in sweeps:
+        name = SWEEP_NAMES.get(s.kind, 'type %d' % s.kind)
+        min_margin = (args.min_gating_margin if s.kind == SWEEP_DQS_GATING
+                      else args.min_margin)
+        print('%s: offsets %d..%d step %d' % (
+            name, s.offset(0), s.offset(len(s.passed[0]) - 1), s.step))
+        for lane in range(lanes):
+            eye = s.eye(lane)
+            if eye is None:
+                margin = None
+                summary = 'FAIL at calibrated value'
+            else:
+                margin = min(-eye[0], eye[1])
+                summary = 'eye %4d..%-4d width %4d margin %4d' % (
+                    eye[0], eye[1], eye[1] - eye[0] + s.step, margin)
+            bad = margin is None or margin < min_margin
+            marginal |= bad
+            print('  lane %d nom 0x%03x %s%s' % (
+                lane, s.nominal[lane], summary, '  MARGINAL' if bad else ''))
+            if not args.quiet:
+                print('    ' + render(s, lane))
+
+    print('RESULT: %s' % ('MARGINAL' if marginal else 'PASS'))
+    return EXIT_MARGINAL if marginal else EXIT_PASS
+
+
+if __name__ == '__main__':
+    sys.exit(main())